@@ -0,0 +1,44 @@
+param(
+    [Parameter(Mandatory = $true)][string]$Image,
+    [int]$Runs = 10
+)
+
+Write-Host "Benchmarking Photo Viewer startup..."
+
+$exe = Join-Path $PSScriptRoot "dist\PhotoViewer.exe"
+if (-not (Test-Path $exe)) {
+    Write-Host "dist\PhotoViewer.exe not found. Run build.ps1 first."
+    exit 1
+}
+
+$windowTimes = @()
+$imageTimes = @()
+$wallTimes = @()
+
+for ($i = 1; $i -le $Runs; $i++) {
+    # Piping makes PowerShell wait for the GUI process and capture its report
+    $stopwatch = [System.Diagnostics.Stopwatch]::StartNew()
+    $report = & $exe --bench-startup $Image | Out-String
+    $wallTimes += $stopwatch.Elapsed.TotalMilliseconds
+    Write-Host "Run $i"
+    Write-Host $report
+
+    if ($report -match "window shown: ([\d\.]+) ms") { $windowTimes += [double]$Matches[1] }
+    if ($report -match "image decoded and painted: ([\d\.]+) ms") {
+        $imageTimes += [double]$Matches[1]
+    } else {
+        Write-Host "Run $i did not paint $Image (missing, unreadable or unsupported file)."
+        exit 1
+    }
+}
+
+function Show-Summary($label, $values) {
+    if ($values.Count -eq 0) { return }
+    $sorted = $values | Sort-Object
+    $median = $sorted[[int][math]::Floor($sorted.Count / 2)]
+    Write-Host ("{0}: median {1:N2} ms, min {2:N2} ms, max {3:N2} ms" -f $label, $median, $sorted[0], $sorted[-1])
+}
+
+Show-Summary "Time to window" $windowTimes
+Show-Summary "Time to image " $imageTimes
+Show-Summary "Launch to exit" $wallTimes
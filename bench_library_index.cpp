@@ -0,0 +1,259 @@
+// Library index benchmark: crawls a synthetic photo tree, then measures
+// reopening the memory-mapped index, incremental updates and filtering.
+//
+//   bench_library_index [--root DIR] [--entries N] [--threads N]
+//
+// The tree is generated once under --root (default ./bench_library) and
+// reused by later runs with the same entry count.
+
+#include "library_index.h"
+
+#include <chrono>
+#include <ctime>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const int FILES_PER_DIRECTORY = 1000;
+const int DIRECTORIES_PER_LEVEL = 32;
+const int TREE_VERSION = 2;
+
+// Synthetic mtimes are spread evenly over 2015-01-01 .. 2025-01-01 (UTC)
+const long long MTIME_FIRST = 1420070400;
+const long long MTIME_LAST = 1735689600;
+const long long YEAR_2020 = 1577836800;
+const long long YEAR_2021 = 1609459200;
+
+double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Smallest headers ProbeDimensions accepts for each format
+size_t MakeImageHeader(int kind, uint32_t width, uint32_t height, uint8_t* out) {
+    switch (kind) {
+        case 0: { // JPEG: SOI, SOF0
+            const uint8_t jpeg[] = { 0xFF, 0xD8, 0xFF, 0xC0, 0x00, 0x11, 0x08,
+                                     (uint8_t)(height >> 8), (uint8_t)height,
+                                     (uint8_t)(width >> 8), (uint8_t)width };
+            memcpy(out, jpeg, sizeof(jpeg));
+            return sizeof(jpeg);
+        }
+        case 1: { // PNG: signature, IHDR
+            const uint8_t png[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n', 0, 0, 0, 13, 'I', 'H', 'D', 'R',
+                                    (uint8_t)(width >> 24), (uint8_t)(width >> 16), (uint8_t)(width >> 8), (uint8_t)width,
+                                    (uint8_t)(height >> 24), (uint8_t)(height >> 16), (uint8_t)(height >> 8), (uint8_t)height };
+            memcpy(out, png, sizeof(png));
+            return sizeof(png);
+        }
+        case 2: { // GIF
+            const uint8_t gif[] = { 'G', 'I', 'F', '8', '9', 'a',
+                                    (uint8_t)width, (uint8_t)(width >> 8), (uint8_t)height, (uint8_t)(height >> 8) };
+            memcpy(out, gif, sizeof(gif));
+            return sizeof(gif);
+        }
+        default: { // BMP with BITMAPINFOHEADER
+            uint8_t bmp[26] = { 'B', 'M' };
+            bmp[14] = 40;
+            for (int i = 0; i < 4; i++) {
+                bmp[18 + i] = (uint8_t)(width >> (8 * i));
+                bmp[22 + i] = (uint8_t)(height >> (8 * i));
+            }
+            memcpy(out, bmp, sizeof(bmp));
+            return sizeof(bmp);
+        }
+    }
+}
+
+const char* EXTENSIONS[] = { ".jpg", ".png", ".gif", ".bmp" };
+
+std::string SyntheticPath(const fs::path& root, long long i) {
+    long long directory = i / FILES_PER_DIRECTORY;
+    char relative[96];
+    snprintf(relative, sizeof(relative), "d%02lld/d%02lld/d%04lld/IMG_%07lld%s",
+             directory % DIRECTORIES_PER_LEVEL, (directory / DIRECTORIES_PER_LEVEL) % DIRECTORIES_PER_LEVEL,
+             directory, i, EXTENSIONS[i % 4]);
+    return (root / relative).string();
+}
+
+bool GenerateTree(const fs::path& root, long long entries) {
+    fs::path marker = root / ".bench_entries";
+    FILE* existing = fopen(marker.string().c_str(), "r");
+    if (existing) {
+        long long count = 0;
+        int version = 0;
+        bool same = fscanf(existing, "%lld %d", &count, &version) == 2
+            && count == entries && version == TREE_VERSION;
+        fclose(existing);
+        if (same) return true;
+    }
+
+    printf("Generating %lld files under %s...\n", entries, root.string().c_str());
+    std::error_code error;
+    fs::remove_all(root, error);
+
+    auto start = std::chrono::steady_clock::now();
+    auto systemNow = std::chrono::system_clock::now();
+    auto fileNow = fs::file_time_type::clock::now();
+    uint8_t header[32];
+    for (long long i = 0; i < entries; i++) {
+        std::string path = SyntheticPath(root, i);
+        if (i % FILES_PER_DIRECTORY == 0) {
+            fs::create_directories(fs::path(path).parent_path(), error);
+        }
+        FILE* file = fopen(path.c_str(), "wb");
+        if (!file) {
+            fprintf(stderr, "Cannot create %s\n", path.c_str());
+            return false;
+        }
+        size_t length = MakeImageHeader((int)(i % 4), 640 + (uint32_t)(i % 5000), 480 + (uint32_t)(i % 3000), header);
+        fwrite(header, 1, length, file);
+        fclose(file);
+
+        // There is no portable C++17 conversion to the file clock, so go
+        // through the offset between the two clocks
+        long long seconds = MTIME_FIRST + (MTIME_LAST - MTIME_FIRST) * i / entries;
+        auto age = std::chrono::system_clock::from_time_t((time_t)seconds) - systemNow;
+        fs::last_write_time(path, fileNow + std::chrono::duration_cast<fs::file_time_type::duration>(age), error);
+    }
+
+    FILE* file = fopen(marker.string().c_str(), "w");
+    if (file) {
+        fprintf(file, "%lld %d\n", entries, TREE_VERSION);
+        fclose(file);
+    }
+    printf("  generated in %.0f ms\n", MillisecondsSince(start));
+    return true;
+}
+
+void PrintBuild(const char* label, const LibraryBuildStats& stats, double totalMs) {
+    printf("%-22s %9.1f ms  (crawl %.1f, probe %.1f, write %.1f)  %llu dirs (%llu failed), %llu files, %llu reused, %llu probed (%llu failed)\n",
+           label, totalMs, stats.crawlMs, stats.probeMs, stats.writeMs,
+           (unsigned long long)stats.directories, (unsigned long long)stats.failedDirectories,
+           (unsigned long long)stats.files,
+           (unsigned long long)stats.reused, (unsigned long long)stats.probed,
+           (unsigned long long)stats.failedFiles);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    fs::path root = "bench_library";
+    long long entries = 1000000;
+    unsigned threads = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--root") == 0 && i + 1 < argc) {
+            root = argv[++i];
+        } else if (strcmp(argv[i], "--entries") == 0 && i + 1 < argc) {
+            entries = atoll(argv[++i]);
+            if (entries < 1) {
+                fprintf(stderr, "--entries must be at least 1\n");
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = (unsigned)atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--root DIR] [--entries N] [--threads N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    root = fs::absolute(root);
+    if (!GenerateTree(root, entries)) return 1;
+
+    // The index API takes UTF-8; string() would use the ANSI code page on Windows
+    std::string rootPath = root.u8string();
+    fs::path indexFile = root;
+    indexFile += ".idx";
+    std::string indexPath = indexFile.u8string();
+    std::error_code error;
+    fs::remove(indexPath, error);
+
+    // Full crawl with no previous index
+    LibraryBuildStats stats;
+    auto start = std::chrono::steady_clock::now();
+    if (!BuildLibraryIndex(rootPath, indexPath, threads, &stats)) {
+        fprintf(stderr, "Index build failed\n");
+        return 1;
+    }
+    PrintBuild("cold build", stats, MillisecondsSince(start));
+    printf("%-22s %9.1f MB\n", "index size", fs::file_size(indexPath) / (1024.0 * 1024.0));
+
+    // Reopen: map the file and touch the first and last entry
+    const int reopenRuns = 20;
+    double reopenTotal = 0.0;
+    size_t count = 0;
+    for (int run = 0; run < reopenRuns; run++) {
+        start = std::chrono::steady_clock::now();
+        LibraryIndex index;
+        if (!index.Open(indexPath)) {
+            fprintf(stderr, "Index open failed\n");
+            return 1;
+        }
+        count = index.Count();
+        volatile size_t touch = index.Path(0).size() + index.Path(count - 1).size();
+        (void)touch;
+        reopenTotal += MillisecondsSince(start);
+    }
+    printf("%-22s %9.3f ms  (%zu entries, mean of %d)\n", "reopen", reopenTotal / reopenRuns, count, reopenRuns);
+
+    // Incremental update with nothing changed
+    start = std::chrono::steady_clock::now();
+    if (!BuildLibraryIndex(rootPath, indexPath, threads, &stats)) {
+        fprintf(stderr, "Incremental index build failed\n");
+        return 1;
+    }
+    PrintBuild("incremental (no-op)", stats, MillisecondsSince(start));
+
+    // Incremental update after touching 1% of the files
+    auto now = fs::file_time_type::clock::now();
+    for (long long i = 0; i < entries; i += 100) {
+        fs::last_write_time(SyntheticPath(root, i), now, error);
+    }
+    start = std::chrono::steady_clock::now();
+    if (!BuildLibraryIndex(rootPath, indexPath, threads, &stats)) {
+        fprintf(stderr, "Incremental index build failed\n");
+        return 1;
+    }
+    PrintBuild("incremental (1% new)", stats, MillisecondsSince(start));
+
+    // Filtering over the mapped columns
+    LibraryIndex index;
+    if (!index.Open(indexPath)) {
+        fprintf(stderr, "Index open failed\n");
+        return 1;
+    }
+    std::vector<uint32_t> results;
+    results.reserve(index.Count());
+
+    struct Query {
+        const char* label;
+        LibraryFilter filter;
+    };
+    std::vector<Query> queries(3);
+    queries[0].label = "filter: png";
+    queries[0].filter.extensionMask = LIBRARY_EXT_MASK(LIBRARY_EXT_PNG);
+    queries[1].label = "filter: >=4000 px wide";
+    queries[1].filter.minWidth = 4000;
+    queries[2].label = "filter: jpeg from 2020";
+    queries[2].filter.extensionMask = LIBRARY_EXT_MASK(LIBRARY_EXT_JPEG);
+    queries[2].filter.mtimeMin = YEAR_2020 * 1000000000LL;
+    queries[2].filter.mtimeMax = YEAR_2021 * 1000000000LL - 1;
+    queries[2].filter.minHeight = 1000;
+    queries[2].filter.maxHeight = 2000;
+
+    for (const Query& query : queries) {
+        start = std::chrono::steady_clock::now();
+        results.clear();
+        index.Query(query.filter, results);
+        printf("%-22s %9.3f ms  (%zu matches)\n", query.label, MillisecondsSince(start), results.size());
+    }
+    return 0;
+}
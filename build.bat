@@ -5,8 +5,13 @@ REM Create dist directory if it doesn't exist
 if not exist "dist" mkdir dist
 
 REM Compile with static linking
-C:\mingw64\bin\g++.exe -o dist/PhotoViewer.exe main.cpp -mwindows
+C:\mingw64\bin\g++.exe -o dist/PhotoViewer.exe main.cpp -lgdiplus -lcomctl32 -mwindows
+if %ERRORLEVEL% NEQ 0 goto done
 
+REM Library index benchmark (console program)
+C:\mingw64\bin\g++.exe -std=c++17 -O2 -o dist/bench_library_index.exe bench_library_index.cpp library_index.cpp
+
+:done
 if %ERRORLEVEL% EQU 0 (
     echo Build successful! Distribution package created in 'dist' folder.
     echo You can now share the 'dist' folder with others.
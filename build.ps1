@@ -11,6 +11,11 @@ $env:Path += ";C:\mingw64\bin"
 # Compile with static linking
 g++ -o dist/PhotoViewer.exe main.cpp -lgdiplus -lcomctl32 -mwindows -static -static-libgcc -static-libstdc++
 
+# Library index benchmark (console program)
+if ($LASTEXITCODE -eq 0) {
+    g++ -std=c++17 -O2 -o dist/bench_library_index.exe bench_library_index.cpp library_index.cpp -static -static-libgcc -static-libstdc++
+}
+
 if ($LASTEXITCODE -eq 0) {
     Write-Host "Build successful! Distribution package created in 'dist' folder."
     Write-Host "You can now share the 'dist' folder with others."
@@ -0,0 +1,775 @@
+#include "library_index.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#define NOMINMAX
+#ifndef _WIN32_WINNT
+#define _WIN32_WINNT 0x0601 // FindExInfoBasic, FIND_FIRST_EX_LARGE_FETCH
+#endif
+#include <windows.h>
+#include <cwchar>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+struct CrawlEntry {
+    std::string path;   // relative to the root, '/' separated
+    uint64_t size;
+    int64_t mtime;
+    uint32_t width;
+    uint32_t height;
+    LibraryExtension extension;
+};
+
+double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::string JoinPath(const std::string& root, const std::string& relative) {
+    if (relative.empty()) return root;
+#ifdef _WIN32
+    std::string path = root + "\\" + relative;
+    std::replace(path.begin(), path.end(), '/', '\\');
+    return path;
+#else
+    return root + "/" + relative;
+#endif
+}
+
+#ifdef _WIN32
+std::wstring Utf8ToWide(const std::string& text) {
+    int length = MultiByteToWideChar(CP_UTF8, 0, text.c_str(), (int)text.size(), NULL, 0);
+    std::wstring result(length, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, text.c_str(), (int)text.size(), &result[0], length);
+    return result;
+}
+
+std::string WideToUtf8(const wchar_t* text) {
+    int length = WideCharToMultiByte(CP_UTF8, 0, text, -1, NULL, 0, NULL, NULL);
+    if (length <= 1) return std::string();
+    std::string result(length - 1, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, text, -1, &result[0], length, NULL, NULL);
+    return result;
+}
+
+// Win32 file APIs stop at MAX_PATH unless absolute paths carry the long
+// path prefix; without it deep subtrees would drop out of the index
+std::wstring LongPath(const std::string& path) {
+    std::wstring wide = Utf8ToWide(path);
+    std::replace(wide.begin(), wide.end(), L'/', L'\\');
+    if (wide.compare(0, 4, L"\\\\?\\") == 0) return wide;
+    if (wide.size() >= 3 && wide[1] == L':' && wide[2] == L'\\') return L"\\\\?\\" + wide;
+    if (wide.compare(0, 2, L"\\\\") == 0) return L"\\\\?\\UNC\\" + wide.substr(2);
+    return wide;
+}
+
+std::string FullPath(const std::string& path) {
+    std::wstring wide = Utf8ToWide(path);
+    DWORD length = GetFullPathNameW(wide.c_str(), 0, NULL, NULL);
+    if (length == 0) return path;
+    std::wstring full(length, L'\0');
+    length = GetFullPathNameW(wide.c_str(), length, &full[0], NULL);
+    if (length == 0 || length >= full.size()) return path;
+    full.resize(length);
+    return WideToUtf8(full.c_str());
+}
+#else
+std::string FullPath(const std::string& path) {
+    char* resolved = realpath(path.c_str(), NULL);
+    if (!resolved) return path;
+    std::string full = resolved;
+    free(resolved);
+    return full;
+}
+#endif
+
+// Positional reads from a single file, used to sniff image headers
+class ImageFile {
+public:
+    explicit ImageFile(const std::string& path) {
+#ifdef _WIN32
+        m_handle = CreateFileW(LongPath(path).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                               NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+#else
+        m_fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+#endif
+    }
+
+    ~ImageFile() {
+#ifdef _WIN32
+        if (m_handle != INVALID_HANDLE_VALUE) CloseHandle(m_handle);
+#else
+        if (m_fd >= 0) close(m_fd);
+#endif
+    }
+
+    bool IsOpen() const {
+#ifdef _WIN32
+        return m_handle != INVALID_HANDLE_VALUE;
+#else
+        return m_fd >= 0;
+#endif
+    }
+
+    bool Read(uint64_t offset, void* buffer, size_t length) {
+#ifdef _WIN32
+        if (m_handle == INVALID_HANDLE_VALUE) return false;
+        OVERLAPPED overlapped = { 0 };
+        overlapped.Offset = (DWORD)offset;
+        overlapped.OffsetHigh = (DWORD)(offset >> 32);
+        DWORD read = 0;
+        return ReadFile(m_handle, buffer, (DWORD)length, &read, &overlapped) && read == length;
+#else
+        if (m_fd < 0) return false;
+        return pread(m_fd, buffer, length, (off_t)offset) == (ssize_t)length;
+#endif
+    }
+
+private:
+#ifdef _WIN32
+    HANDLE m_handle = INVALID_HANDLE_VALUE;
+#else
+    int m_fd = -1;
+#endif
+};
+
+uint32_t ReadBE16(const uint8_t* p) { return (p[0] << 8) | p[1]; }
+uint32_t ReadLE16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+uint32_t ReadBE32(const uint8_t* p) { return ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3]; }
+uint32_t ReadLE32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+
+// Reads the image dimensions from the file header without decoding pixels
+bool ProbeDimensions(ImageFile& file, LibraryExtension extension, uint32_t* width, uint32_t* height) {
+    uint8_t header[26];
+
+    switch (extension) {
+        case LIBRARY_EXT_PNG:
+            if (!file.Read(0, header, 24)) return false;
+            if (memcmp(header, "\x89PNG\r\n\x1a\n", 8) != 0 || memcmp(header + 12, "IHDR", 4) != 0) return false;
+            *width = ReadBE32(header + 16);
+            *height = ReadBE32(header + 20);
+            return true;
+
+        case LIBRARY_EXT_GIF:
+            if (!file.Read(0, header, 10)) return false;
+            if (memcmp(header, "GIF8", 4) != 0) return false;
+            *width = ReadLE16(header + 6);
+            *height = ReadLE16(header + 8);
+            return true;
+
+        case LIBRARY_EXT_BMP:
+        {
+            if (!file.Read(0, header, 26)) return false;
+            if (header[0] != 'B' || header[1] != 'M') return false;
+            if (ReadLE32(header + 14) == 12) {
+                *width = ReadLE16(header + 18);
+                *height = ReadLE16(header + 20);
+            } else {
+                int32_t h = (int32_t)ReadLE32(header + 22);
+                *width = ReadLE32(header + 18);
+                *height = (uint32_t)(h < 0 ? -h : h);
+            }
+            return true;
+        }
+
+        case LIBRARY_EXT_JPEG:
+        {
+            if (!file.Read(0, header, 2) || header[0] != 0xFF || header[1] != 0xD8) return false;
+            uint64_t offset = 2;
+            // Walk the segment list until the first start-of-frame marker
+            for (int segment = 0; segment < 256; segment++) {
+                if (!file.Read(offset, header, 4) || header[0] != 0xFF) return false;
+                uint8_t marker = header[1];
+                if (marker == 0xFF) {
+                    offset++;
+                    continue;
+                }
+                if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+                    offset += 2;
+                    continue;
+                }
+                if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+                    if (!file.Read(offset + 5, header, 4)) return false;
+                    *height = ReadBE16(header);
+                    *width = ReadBE16(header + 2);
+                    return true;
+                }
+                if (marker == 0xD9 || marker == 0xDA) return false;
+                offset += 2 + ReadBE16(header + 2);
+            }
+            return false;
+        }
+
+        default:
+            return false;
+    }
+}
+
+// Parallel directory crawl. Directories are handed out from a shared queue;
+// each worker collects files into its own vector so the hot path takes no
+// locks.
+class Crawler {
+public:
+    Crawler(const std::string& root, unsigned threadCount)
+        : m_root(root), m_threadCount(threadCount), m_results(threadCount) {}
+
+    // Returns false if the root itself could not be listed
+    bool Run(std::vector<CrawlEntry>& entries, LibraryBuildStats* stats) {
+        m_queue.push_back(std::string());
+        m_pending = 1;
+
+        std::vector<std::thread> threads;
+        for (unsigned i = 0; i < m_threadCount; i++) {
+            threads.emplace_back(&Crawler::Worker, this, i);
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        size_t total = 0;
+        for (const std::vector<CrawlEntry>& result : m_results) total += result.size();
+        entries.clear();
+        entries.reserve(total);
+        for (std::vector<CrawlEntry>& result : m_results) {
+            std::move(result.begin(), result.end(), std::back_inserter(entries));
+            result.clear();
+            result.shrink_to_fit();
+        }
+
+        stats->directories = m_directories;
+        stats->failedDirectories = m_failedDirectories;
+        return !m_rootFailed;
+    }
+
+private:
+    void Worker(unsigned index) {
+        std::vector<CrawlEntry>& files = m_results[index];
+        std::vector<std::string> subdirectories;
+
+        for (;;) {
+            std::string directory;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock, [this] { return !m_queue.empty() || m_pending == 0; });
+                if (m_queue.empty()) return;
+                directory = std::move(m_queue.front());
+                m_queue.pop_front();
+            }
+
+            subdirectories.clear();
+            if (ListDirectory(directory, files, subdirectories)) {
+                m_directories++;
+            } else if (directory.empty()) {
+                m_rootFailed = true;
+            } else {
+                m_failedDirectories++;
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (std::string& subdirectory : subdirectories) {
+                m_queue.push_back(std::move(subdirectory));
+            }
+            m_pending += subdirectories.size();
+            m_pending--;
+            if (m_pending == 0 || subdirectories.size() > 1) {
+                m_wake.notify_all();
+            } else if (!subdirectories.empty()) {
+                m_wake.notify_one();
+            }
+        }
+    }
+
+    static std::string ChildPath(const std::string& directory, const char* name) {
+        return directory.empty() ? std::string(name) : directory + "/" + name;
+    }
+
+    // Returns false if the directory could not be opened or read completely
+    bool ListDirectory(const std::string& directory, std::vector<CrawlEntry>& files,
+                       std::vector<std::string>& subdirectories) {
+#ifdef _WIN32
+        // Basic info + large fetch returns size and mtime without a per-file open
+        WIN32_FIND_DATAW findData;
+        std::wstring pattern = LongPath(JoinPath(m_root, directory)) + L"\\*";
+        HANDLE hFind = FindFirstFileExW(pattern.c_str(), FindExInfoBasic, &findData,
+                                        FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+        // A drive root has no "." entry, so an empty one reports no match
+        if (hFind == INVALID_HANDLE_VALUE) return GetLastError() == ERROR_FILE_NOT_FOUND;
+        do {
+            const wchar_t* name = findData.cFileName;
+            if (wcscmp(name, L".") == 0 || wcscmp(name, L"..") == 0) continue;
+            if (findData.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) continue;
+
+            std::string utf8Name = WideToUtf8(name);
+            if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+                subdirectories.push_back(ChildPath(directory, utf8Name.c_str()));
+                continue;
+            }
+            LibraryExtension extension = LibraryExtensionFromPath(utf8Name);
+            if (extension == LIBRARY_EXT_UNKNOWN) continue;
+
+            uint64_t ticks = ((uint64_t)findData.ftLastWriteTime.dwHighDateTime << 32) | findData.ftLastWriteTime.dwLowDateTime;
+            CrawlEntry entry;
+            entry.path = ChildPath(directory, utf8Name.c_str());
+            entry.size = ((uint64_t)findData.nFileSizeHigh << 32) | findData.nFileSizeLow;
+            entry.mtime = ((int64_t)ticks - 116444736000000000LL) * 100;
+            entry.width = 0;
+            entry.height = 0;
+            entry.extension = extension;
+            files.push_back(std::move(entry));
+        } while (FindNextFileW(hFind, &findData));
+        bool complete = GetLastError() == ERROR_NO_MORE_FILES;
+        FindClose(hFind);
+        return complete;
+#else
+        int fd = open(JoinPath(m_root, directory).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0) return false;
+        DIR* dir = fdopendir(fd);
+        if (!dir) {
+            close(fd);
+            return false;
+        }
+
+        for (;;) {
+            errno = 0;
+            struct dirent* item = readdir(dir);
+            if (!item) break;
+            const char* name = item->d_name;
+            if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) continue;
+
+            unsigned char type = item->d_type;
+            LibraryExtension extension = LIBRARY_EXT_UNKNOWN;
+            if (type != DT_DIR) {
+                extension = LibraryExtensionFromPath(name);
+                // Only image files and unknown types are worth a stat
+                if (extension == LIBRARY_EXT_UNKNOWN && type != DT_UNKNOWN) continue;
+            }
+
+            if (type == DT_DIR) {
+                subdirectories.push_back(ChildPath(directory, name));
+                continue;
+            }
+            if (type != DT_REG && type != DT_UNKNOWN) continue;
+
+            struct stat st;
+            if (fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) continue;
+            if (S_ISDIR(st.st_mode)) {
+                subdirectories.push_back(ChildPath(directory, name));
+                continue;
+            }
+            if (!S_ISREG(st.st_mode) || extension == LIBRARY_EXT_UNKNOWN) continue;
+
+            CrawlEntry entry;
+            entry.path = ChildPath(directory, name);
+            entry.size = (uint64_t)st.st_size;
+            entry.mtime = (int64_t)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+            entry.width = 0;
+            entry.height = 0;
+            entry.extension = extension;
+            files.push_back(std::move(entry));
+        }
+        bool complete = errno == 0;
+        closedir(dir);
+        return complete;
+#endif
+    }
+
+    std::string m_root;
+    unsigned m_threadCount;
+    std::vector<std::vector<CrawlEntry>> m_results;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<std::string> m_queue;
+    size_t m_pending = 0;   // queued plus in-progress directories
+    std::atomic<uint64_t> m_directories{0};
+    std::atomic<uint64_t> m_failedDirectories{0};
+    std::atomic<bool> m_rootFailed{false};
+};
+
+uint64_t AlignUp(uint64_t value) {
+    return (value + 7) & ~(uint64_t)7;
+}
+
+bool WriteColumn(FILE* file, const void* data, size_t bytes) {
+    static const char padding[8] = { 0 };
+    if (bytes && fwrite(data, 1, bytes, file) != bytes) return false;
+    size_t pad = (size_t)(AlignUp(bytes) - bytes);
+    return pad == 0 || fwrite(padding, 1, pad, file) == pad;
+}
+
+bool WriteIndexFile(const std::string& path, const std::string& root, const std::vector<CrawlEntry>& entries) {
+    size_t count = entries.size();
+
+    LibraryIndexHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, LIBRARY_INDEX_MAGIC, sizeof(header.magic));
+    header.version = LIBRARY_INDEX_VERSION;
+    header.headerSize = sizeof(LibraryIndexHeader);
+    header.entryCount = count;
+    header.rootOffset = 0;
+    header.rootLength = root.size();
+
+    header.pathOffsetsOffset = AlignUp(sizeof(LibraryIndexHeader));
+    header.sizesOffset = header.pathOffsetsOffset + AlignUp((count + 1) * sizeof(uint64_t));
+    header.mtimesOffset = header.sizesOffset + AlignUp(count * sizeof(uint64_t));
+    header.widthsOffset = header.mtimesOffset + AlignUp(count * sizeof(int64_t));
+    header.heightsOffset = header.widthsOffset + AlignUp(count * sizeof(uint32_t));
+    header.extensionsOffset = header.heightsOffset + AlignUp(count * sizeof(uint32_t));
+    header.arenaOffset = header.extensionsOffset + AlignUp(count * sizeof(uint8_t));
+
+    std::vector<uint64_t> pathOffsets(count + 1);
+    uint64_t arenaSize = root.size();
+    for (size_t i = 0; i < count; i++) {
+        pathOffsets[i] = arenaSize;
+        arenaSize += entries[i].path.size();
+    }
+    pathOffsets[count] = arenaSize;
+    header.arenaSize = arenaSize;
+    header.fileSize = header.arenaOffset + AlignUp(arenaSize);
+
+    std::vector<uint64_t> sizes(count);
+    std::vector<int64_t> mtimes(count);
+    std::vector<uint32_t> widths(count);
+    std::vector<uint32_t> heights(count);
+    std::vector<uint8_t> extensions(count);
+    for (size_t i = 0; i < count; i++) {
+        sizes[i] = entries[i].size;
+        mtimes[i] = entries[i].mtime;
+        widths[i] = entries[i].width;
+        heights[i] = entries[i].height;
+        extensions[i] = entries[i].extension;
+    }
+
+#ifdef _WIN32
+    FILE* file = _wfopen(LongPath(path).c_str(), L"wb");
+#else
+    FILE* file = fopen(path.c_str(), "wb");
+#endif
+    if (!file) return false;
+    std::vector<char> buffer(1 << 20);
+    setvbuf(file, buffer.data(), _IOFBF, buffer.size());
+
+    bool ok = WriteColumn(file, &header, sizeof(header))
+        && WriteColumn(file, pathOffsets.data(), pathOffsets.size() * sizeof(uint64_t))
+        && WriteColumn(file, sizes.data(), count * sizeof(uint64_t))
+        && WriteColumn(file, mtimes.data(), count * sizeof(int64_t))
+        && WriteColumn(file, widths.data(), count * sizeof(uint32_t))
+        && WriteColumn(file, heights.data(), count * sizeof(uint32_t))
+        && WriteColumn(file, extensions.data(), count * sizeof(uint8_t));
+
+    // Arena: root, then every path back to back
+    if (ok) ok = root.empty() || fwrite(root.data(), 1, root.size(), file) == root.size();
+    for (size_t i = 0; ok && i < count; i++) {
+        const std::string& entryPath = entries[i].path;
+        ok = fwrite(entryPath.data(), 1, entryPath.size(), file) == entryPath.size();
+    }
+    size_t pad = (size_t)(AlignUp(arenaSize) - arenaSize);
+    if (ok && pad) ok = fwrite("\0\0\0\0\0\0\0", 1, pad, file) == pad;
+
+    if (fclose(file) != 0) ok = false;
+    return ok;
+}
+
+bool ReplaceIndexFile(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+    return MoveFileExW(LongPath(from).c_str(), LongPath(to).c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+void RemoveIndexFile(const std::string& path) {
+#ifdef _WIN32
+    DeleteFileW(LongPath(path).c_str());
+#else
+    unlink(path.c_str());
+#endif
+}
+
+} // namespace
+
+LibraryExtension LibraryExtensionFromPath(std::string_view path) {
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string_view::npos || path.size() - dot > 5) return LIBRARY_EXT_UNKNOWN;
+
+    char ext[5] = { 0 };
+    for (size_t i = dot + 1, j = 0; i < path.size(); i++, j++) {
+        char c = path[i];
+        ext[j] = (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+    }
+    if (strcmp(ext, "jpg") == 0 || strcmp(ext, "jpeg") == 0) return LIBRARY_EXT_JPEG;
+    if (strcmp(ext, "png") == 0) return LIBRARY_EXT_PNG;
+    if (strcmp(ext, "bmp") == 0) return LIBRARY_EXT_BMP;
+    if (strcmp(ext, "gif") == 0) return LIBRARY_EXT_GIF;
+    return LIBRARY_EXT_UNKNOWN;
+}
+
+LibraryIndex::~LibraryIndex() {
+    Close();
+}
+
+bool LibraryIndex::Open(const std::string& indexPath) {
+    Close();
+
+#ifdef _WIN32
+    HANDLE hFile = CreateFileW(LongPath(indexPath).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                               NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(hFile, &fileSize) || fileSize.QuadPart < (LONGLONG)sizeof(LibraryIndexHeader)) {
+        CloseHandle(hFile);
+        return false;
+    }
+    HANDLE hMapping = CreateFileMappingW(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    void* view = hMapping ? MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (!view) {
+        if (hMapping) CloseHandle(hMapping);
+        CloseHandle(hFile);
+        return false;
+    }
+    m_hFile = hFile;
+    m_hMapping = hMapping;
+    m_mapping = view;
+    m_mappingSize = (size_t)fileSize.QuadPart;
+#else
+    int fd = open(indexPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(LibraryIndexHeader)) {
+        close(fd);
+        return false;
+    }
+    void* view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) return false;
+    m_mapping = view;
+    m_mappingSize = (size_t)st.st_size;
+#endif
+
+    const char* base = static_cast<const char*>(m_mapping);
+    const LibraryIndexHeader* header = reinterpret_cast<const LibraryIndexHeader*>(base);
+    uint64_t count = header->entryCount;
+    uint64_t size = m_mappingSize;
+
+    auto columnFits = [&](uint64_t offset, uint64_t bytes) {
+        return offset % 8 == 0 && offset <= size && bytes <= size - offset;
+    };
+    bool valid = memcmp(header->magic, LIBRARY_INDEX_MAGIC, sizeof(header->magic)) == 0
+        && header->version == LIBRARY_INDEX_VERSION
+        && header->headerSize == sizeof(LibraryIndexHeader)
+        && header->fileSize == size
+        && count < size
+        && columnFits(header->pathOffsetsOffset, (count + 1) * sizeof(uint64_t))
+        && columnFits(header->sizesOffset, count * sizeof(uint64_t))
+        && columnFits(header->mtimesOffset, count * sizeof(int64_t))
+        && columnFits(header->widthsOffset, count * sizeof(uint32_t))
+        && columnFits(header->heightsOffset, count * sizeof(uint32_t))
+        && columnFits(header->extensionsOffset, count * sizeof(uint8_t))
+        && columnFits(header->arenaOffset, header->arenaSize)
+        && header->rootOffset <= header->arenaSize
+        && header->rootLength <= header->arenaSize - header->rootOffset;
+    if (!valid) {
+        Close();
+        return false;
+    }
+
+    const uint64_t* pathOffsets = reinterpret_cast<const uint64_t*>(base + header->pathOffsetsOffset);
+    if (pathOffsets[count] > header->arenaSize) {
+        Close();
+        return false;
+    }
+
+    m_header = header;
+    m_pathOffsets = pathOffsets;
+    m_sizes = reinterpret_cast<const uint64_t*>(base + header->sizesOffset);
+    m_mtimes = reinterpret_cast<const int64_t*>(base + header->mtimesOffset);
+    m_widths = reinterpret_cast<const uint32_t*>(base + header->widthsOffset);
+    m_heights = reinterpret_cast<const uint32_t*>(base + header->heightsOffset);
+    m_extensions = reinterpret_cast<const uint8_t*>(base + header->extensionsOffset);
+    m_arena = base + header->arenaOffset;
+    return true;
+}
+
+void LibraryIndex::Close() {
+    if (m_mapping) {
+#ifdef _WIN32
+        UnmapViewOfFile(m_mapping);
+        CloseHandle(m_hMapping);
+        CloseHandle(m_hFile);
+        m_hMapping = nullptr;
+        m_hFile = nullptr;
+#else
+        munmap(m_mapping, m_mappingSize);
+#endif
+    }
+    m_mapping = nullptr;
+    m_mappingSize = 0;
+    m_header = nullptr;
+    m_pathOffsets = nullptr;
+    m_sizes = nullptr;
+    m_mtimes = nullptr;
+    m_widths = nullptr;
+    m_heights = nullptr;
+    m_extensions = nullptr;
+    m_arena = nullptr;
+}
+
+std::string_view LibraryIndex::Root() const {
+    if (!m_header) return std::string_view();
+    return std::string_view(m_arena + m_header->rootOffset, (size_t)m_header->rootLength);
+}
+
+std::string_view LibraryIndex::Path(size_t i) const {
+    // Offsets are only checked at the end of the column on open; clamp so a
+    // damaged file cannot read outside the arena
+    uint64_t arenaSize = m_header->arenaSize;
+    uint64_t begin = std::min(m_pathOffsets[i], arenaSize);
+    uint64_t end = std::min(std::max(m_pathOffsets[i + 1], begin), arenaSize);
+    return std::string_view(m_arena + begin, (size_t)(end - begin));
+}
+
+long long LibraryIndex::Find(std::string_view relativePath) const {
+    size_t low = 0;
+    size_t high = Count();
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (Path(mid) < relativePath) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return (low < Count() && Path(low) == relativePath) ? (long long)low : -1;
+}
+
+void LibraryIndex::Query(const LibraryFilter& filter, std::vector<uint32_t>& results) const {
+    size_t count = Count();
+    bool anyExtension = filter.extensionMask == LIBRARY_EXT_MASK_ALL;
+    for (size_t i = 0; i < count; i++) {
+        if (!anyExtension) {
+            // Values past the known types would be an out-of-range shift
+            uint8_t extension = m_extensions[i];
+            if (extension > LIBRARY_EXT_GIF || !(filter.extensionMask & LIBRARY_EXT_MASK(extension))) continue;
+        }
+        int64_t mtime = m_mtimes[i];
+        if (mtime < filter.mtimeMin || mtime > filter.mtimeMax) continue;
+        uint32_t width = m_widths[i];
+        if (width < filter.minWidth || width > filter.maxWidth) continue;
+        uint32_t height = m_heights[i];
+        if (height < filter.minHeight || height > filter.maxHeight) continue;
+        results.push_back((uint32_t)i);
+    }
+}
+
+bool BuildLibraryIndex(const std::string& rootPath, const std::string& indexPath,
+                       unsigned threadCount, LibraryBuildStats* stats) {
+    // Stored roots are absolute so Root() and the reuse check below do not
+    // depend on the working directory
+    std::string root = FullPath(rootPath);
+    while (root.size() > 1 && (root.back() == '/' || root.back() == '\\')) root.pop_back();
+
+    LibraryBuildStats localStats;
+    if (!stats) stats = &localStats;
+    *stats = LibraryBuildStats();
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    auto start = std::chrono::steady_clock::now();
+    // An unreachable root (unplugged drive, offline share, no permission)
+    // must not replace a good index with an empty one
+    Crawler crawler(root, threadCount);
+    std::vector<CrawlEntry> entries;
+    if (!crawler.Run(entries, stats)) return false;
+    std::sort(entries.begin(), entries.end(),
+              [](const CrawlEntry& a, const CrawlEntry& b) { return a.path < b.path; });
+    stats->files = entries.size();
+    stats->crawlMs = MillisecondsSince(start);
+
+    // Carry dimensions over from the previous index when size and mtime are
+    // unchanged. Both lists are sorted by path, so this is a single merge walk.
+    start = std::chrono::steady_clock::now();
+    std::vector<size_t> toProbe;
+    {
+        LibraryIndex previous;
+        size_t j = 0;
+        size_t previousCount = 0;
+        if (previous.Open(indexPath) && previous.Root() == root) {
+            previousCount = previous.Count();
+        }
+        for (size_t i = 0; i < entries.size(); i++) {
+            CrawlEntry& entry = entries[i];
+            while (j < previousCount && previous.Path(j) < entry.path) j++;
+            if (j < previousCount && previous.Path(j) == entry.path
+                && previous.Size(j) == entry.size && previous.MTime(j) == entry.mtime) {
+                entry.width = previous.Width(j);
+                entry.height = previous.Height(j);
+                stats->reused++;
+            } else {
+                toProbe.push_back(i);
+            }
+        }
+    }
+
+    std::atomic<size_t> next{0};
+    std::atomic<uint64_t> failedFiles{0};
+    auto probeWorker = [&]() {
+        const size_t chunk = 256;
+        for (;;) {
+            size_t first = next.fetch_add(chunk);
+            if (first >= toProbe.size()) return;
+            size_t last = std::min(first + chunk, toProbe.size());
+            for (size_t k = first; k < last; k++) {
+                CrawlEntry& entry = entries[toProbe[k]];
+                ImageFile file(JoinPath(root, entry.path));
+                if (!file.IsOpen()) failedFiles++;
+                if (!ProbeDimensions(file, entry.extension, &entry.width, &entry.height)) {
+                    entry.width = 0;
+                    entry.height = 0;
+                }
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < threadCount && toProbe.size() > 256 * i; i++) {
+        threads.emplace_back(probeWorker);
+    }
+    probeWorker();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    stats->probed = toProbe.size();
+    stats->failedFiles = failedFiles;
+    stats->probeMs = MillisecondsSince(start);
+
+    // Write next to the destination and swap it in, so readers never see a
+    // partially written index
+    start = std::chrono::steady_clock::now();
+    std::string tempPath = indexPath + ".tmp";
+    if (!WriteIndexFile(tempPath, root, entries)) {
+        RemoveIndexFile(tempPath);
+        return false;
+    }
+    if (!ReplaceIndexFile(tempPath, indexPath)) {
+        RemoveIndexFile(tempPath);
+        return false;
+    }
+    stats->writeMs = MillisecondsSince(start);
+    return true;
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Image types tracked by the library index. Values are stored on disk.
+enum LibraryExtension : uint8_t {
+    LIBRARY_EXT_UNKNOWN = 0,
+    LIBRARY_EXT_JPEG = 1,
+    LIBRARY_EXT_PNG = 2,
+    LIBRARY_EXT_BMP = 3,
+    LIBRARY_EXT_GIF = 4
+};
+
+#define LIBRARY_EXT_MASK(ext) (1u << (ext))
+#define LIBRARY_EXT_MASK_ALL 0xFFFFFFFFu
+
+// On-disk layout (little endian, every column 8-byte aligned):
+//   LibraryIndexHeader
+//   uint64_t pathOffsets[entryCount + 1]  offsets into the string arena
+//   uint64_t sizes[entryCount]            file size in bytes
+//   int64_t  mtimes[entryCount]           modification time, ns since Unix epoch
+//   uint32_t widths[entryCount]           0 if the header could not be read
+//   uint32_t heights[entryCount]
+//   uint8_t  extensions[entryCount]       LibraryExtension
+//   char     arena[arenaSize]             root path, then UTF-8 paths relative to it
+// Entries are sorted by relative path, which uses '/' as separator.
+#define LIBRARY_INDEX_MAGIC "PVLIBIDX"
+#define LIBRARY_INDEX_VERSION 1
+
+struct LibraryIndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t fileSize;
+    uint64_t entryCount;
+    uint64_t rootOffset;
+    uint64_t rootLength;
+    uint64_t pathOffsetsOffset;
+    uint64_t sizesOffset;
+    uint64_t mtimesOffset;
+    uint64_t widthsOffset;
+    uint64_t heightsOffset;
+    uint64_t extensionsOffset;
+    uint64_t arenaOffset;
+    uint64_t arenaSize;
+};
+
+// Range filter over the index columns. Default values mean "no limit".
+// Entries whose header could not be read have width and height 0, so any
+// minWidth/minHeight above 0 excludes them.
+struct LibraryFilter {
+    uint32_t extensionMask = LIBRARY_EXT_MASK_ALL;
+    int64_t mtimeMin = INT64_MIN;
+    int64_t mtimeMax = INT64_MAX;
+    uint32_t minWidth = 0;
+    uint32_t maxWidth = UINT32_MAX;
+    uint32_t minHeight = 0;
+    uint32_t maxHeight = UINT32_MAX;
+};
+
+struct LibraryBuildStats {
+    uint64_t directories = 0;
+    uint64_t failedDirectories = 0; // subdirectories that could not be listed
+    uint64_t files = 0;
+    uint64_t reused = 0;    // entries whose size and mtime matched the previous index
+    uint64_t probed = 0;    // entries whose image header had to be read
+    uint64_t failedFiles = 0;   // probed entries that could not be opened
+    double crawlMs = 0.0;
+    double probeMs = 0.0;
+    double writeMs = 0.0;
+};
+
+// Read-only view of an index file, memory-mapped so opening costs only the
+// header validation regardless of how many entries the library has.
+class LibraryIndex {
+public:
+    LibraryIndex() = default;
+    ~LibraryIndex();
+    LibraryIndex(const LibraryIndex&) = delete;
+    LibraryIndex& operator=(const LibraryIndex&) = delete;
+
+    bool Open(const std::string& indexPath);
+    void Close();
+    bool IsOpen() const { return m_header != nullptr; }
+
+    size_t Count() const { return m_header ? (size_t)m_header->entryCount : 0; }
+    std::string_view Root() const;
+    std::string_view Path(size_t i) const;
+    uint64_t Size(size_t i) const { return m_sizes[i]; }
+    int64_t MTime(size_t i) const { return m_mtimes[i]; }
+    uint32_t Width(size_t i) const { return m_widths[i]; }
+    uint32_t Height(size_t i) const { return m_heights[i]; }
+    LibraryExtension Extension(size_t i) const { return (LibraryExtension)m_extensions[i]; }
+
+    // Returns the entry for a relative path, or -1
+    long long Find(std::string_view relativePath) const;
+
+    // Appends the indices of all matching entries to results
+    void Query(const LibraryFilter& filter, std::vector<uint32_t>& results) const;
+
+private:
+    const LibraryIndexHeader* m_header = nullptr;
+    const uint64_t* m_pathOffsets = nullptr;
+    const uint64_t* m_sizes = nullptr;
+    const int64_t* m_mtimes = nullptr;
+    const uint32_t* m_widths = nullptr;
+    const uint32_t* m_heights = nullptr;
+    const uint8_t* m_extensions = nullptr;
+    const char* m_arena = nullptr;
+
+    void* m_mapping = nullptr;
+    size_t m_mappingSize = 0;
+#ifdef _WIN32
+    void* m_hFile = nullptr;
+    void* m_hMapping = nullptr;
+#endif
+};
+
+// Crawls root (UTF-8) recursively with threadCount workers (0 = hardware
+// concurrency) and writes a new index to indexPath. If an index already
+// exists there for the same root, entries whose size and mtime are
+// unchanged keep their dimensions without reopening the image.
+// Returns false without touching indexPath if root cannot be listed;
+// unreadable subdirectories are skipped and counted in stats.
+bool BuildLibraryIndex(const std::string& root, const std::string& indexPath,
+                       unsigned threadCount, LibraryBuildStats* stats);
+
+LibraryExtension LibraryExtensionFromPath(std::string_view path);
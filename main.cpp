@@ -31,6 +31,29 @@
 #define STATUS_PART_FILENAME 2
 #define STATUS_PART_FILESIZE 3
 
+// Private window messages
+#define WM_APP_IMAGE_DECODED (WM_APP + 1)
+
+// WM_COPYDATA tag used when a second instance hands its file to this one
+#define COPYDATA_OPEN_FILE 0x464F5650 // 'PVOF'
+
+const char CLASS_NAME[] = "Photo Viewer";
+const wchar_t SINGLE_INSTANCE_MUTEX[] = L"PhotoViewer.SingleInstance";
+
+// Result of a background decode, posted back to the UI thread
+struct DecodeRequest {
+    HWND hwnd;
+    LONG generation;
+    std::wstring filename;
+    Gdiplus::Bitmap* bitmap;
+    double decodeMs;
+};
+
+struct StartupPhase {
+    const char* name;
+    double ms;
+};
+
 // Global variables
 std::unique_ptr<Gdiplus::Bitmap> g_pBitmap;
 std::unique_ptr<Gdiplus::Bitmap> g_pBufferedBitmap;
@@ -49,9 +72,36 @@ bool g_darkMode = false;
 UINT_PTR g_zoomTimerId = 1;
 bool g_isZooming = false;
 float g_zoomSpeed = 1.1f;
+HANDLE g_gdiplusReady = NULL;
+volatile LONG g_decodeGeneration = 0;
+
+// Single decode worker; g_pendingDecode holds only the latest request
+HANDLE g_decodeThread = NULL;
+HANDLE g_decodeWake = NULL;
+CRITICAL_SECTION g_decodeLock;
+DecodeRequest* g_pendingDecode = NULL;
+bool g_decodeStop = false;
+
+// Startup instrumentation
+LARGE_INTEGER g_startupCounter;
+LARGE_INTEGER g_counterFrequency;
+std::vector<StartupPhase> g_startupPhases;
+double g_gdiplusReadyMs = 0.0;
+bool g_startupImagePending = false;
+bool g_benchStartup = false;
 
 // Function declarations
 void LoadImage(HWND hwnd, LPCWSTR filename);
+void ShowImage(HWND hwnd, Gdiplus::Bitmap* bitmap, const std::wstring& filename);
+DWORD WINAPI GdiplusStartupThreadProc(LPVOID param);
+DWORD WINAPI DecodeThreadProc(LPVOID param);
+void DecodeImage(DecodeRequest* request);
+void StopDecodeThread();
+void StartStartupClock();
+double ElapsedStartupMs();
+void MarkStartupPhase(const char* name);
+void ReportStartupPhases();
+bool HandOffToRunningInstance(const std::wstring& filename);
 void UpdateBufferedBitmap(HWND hwnd);
 void UpdateStatusBar(HWND hwnd);
 bool IsImageFile(const std::wstring& filename);
@@ -184,29 +234,216 @@ void LoadImageDirectory(const std::wstring& currentFile) {
     std::sort(g_imageFiles.begin(), g_imageFiles.end());
 }
 
+void StartStartupClock() {
+    QueryPerformanceFrequency(&g_counterFrequency);
+
+    // Time zero is process creation, so loader work and static imports
+    // (gdiplus.dll, comctl32.dll) are part of every phase. The precise
+    // clock is Windows 8+; older systems fall back to the coarse one.
+    typedef VOID (WINAPI *GetSystemTimeFn)(LPFILETIME);
+    GetSystemTimeFn getSystemTime = (GetSystemTimeFn)GetProcAddress(
+        GetModuleHandleA("kernel32.dll"), "GetSystemTimePreciseAsFileTime");
+    if (!getSystemTime) getSystemTime = GetSystemTimeAsFileTime;
+
+    FILETIME now, creation, exitTime, kernelTime, userTime;
+    getSystemTime(&now);
+    QueryPerformanceCounter(&g_startupCounter);
+    if (GetProcessTimes(GetCurrentProcess(), &creation, &exitTime, &kernelTime, &userTime)) {
+        ULARGE_INTEGER nowTicks, creationTicks;
+        nowTicks.LowPart = now.dwLowDateTime;
+        nowTicks.HighPart = now.dwHighDateTime;
+        creationTicks.LowPart = creation.dwLowDateTime;
+        creationTicks.HighPart = creation.dwHighDateTime;
+        if (nowTicks.QuadPart > creationTicks.QuadPart) {
+            // FILETIME ticks are 100 ns
+            double seconds = (nowTicks.QuadPart - creationTicks.QuadPart) / 10000000.0;
+            g_startupCounter.QuadPart -= (LONGLONG)(seconds * g_counterFrequency.QuadPart);
+        }
+    }
+    MarkStartupPhase("WinMain entered");
+}
+
+double ElapsedStartupMs() {
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return (now.QuadPart - g_startupCounter.QuadPart) * 1000.0 / g_counterFrequency.QuadPart;
+}
+
+void MarkStartupPhase(const char* name) {
+    g_startupPhases.push_back({ name, ElapsedStartupMs() });
+}
+
+void ReportStartupPhases() {
+    std::ostringstream report;
+    report << std::fixed << std::setprecision(2);
+    // g_gdiplusReadyMs is written by the startup thread before it signals
+    // the event, so it may only be read once the event is set
+    if (WaitForSingleObject(g_gdiplusReady, 0) == WAIT_OBJECT_0) {
+        report << "gdi+ ready (background): " << g_gdiplusReadyMs << " ms\r\n";
+    } else {
+        report << "gdi+ ready (background): pending\r\n";
+    }
+    for (const StartupPhase& phase : g_startupPhases) {
+        report << phase.name << ": " << phase.ms << " ms\r\n";
+    }
+    std::string text = report.str();
+    OutputDebugStringA(text.c_str());
+
+    // With --bench-startup the report also goes to stdout so a script can
+    // capture it by piping the (GUI subsystem) process
+    if (g_benchStartup) {
+        HANDLE hOut = GetStdHandle(STD_OUTPUT_HANDLE);
+        if (hOut != NULL && hOut != INVALID_HANDLE_VALUE) {
+            DWORD written = 0;
+            WriteFile(hOut, text.c_str(), (DWORD)text.size(), &written, NULL);
+        }
+    }
+}
+
+DWORD WINAPI GdiplusStartupThreadProc(LPVOID param) {
+    // GDI+ startup is the slowest part of launch, so it runs off the UI
+    // thread while the window is created and shown
+    Gdiplus::GdiplusStartupInput gdiplusStartupInput;
+    Gdiplus::GdiplusStartup(&g_gdiplusToken, &gdiplusStartupInput, NULL);
+    g_gdiplusReadyMs = ElapsedStartupMs();
+    SetEvent(g_gdiplusReady);
+    return 0;
+}
+
+void DecodeImage(DecodeRequest* request) {
+    // Skip requests that were superseded while waiting for the worker
+    if (request->generation != g_decodeGeneration) return;
+
+    LARGE_INTEGER start, end;
+    QueryPerformanceCounter(&start);
+    request->bitmap = new Gdiplus::Bitmap(request->filename.c_str());
+    if (request->generation != g_decodeGeneration) {
+        delete request->bitmap;
+        request->bitmap = NULL;
+        return;
+    }
+    // Force the full decode here rather than on first draw
+    if (request->bitmap->GetLastStatus() == Gdiplus::Ok) {
+        Gdiplus::Rect bounds(0, 0, request->bitmap->GetWidth(), request->bitmap->GetHeight());
+        Gdiplus::BitmapData data;
+        if (request->bitmap->LockBits(&bounds, Gdiplus::ImageLockModeRead, PixelFormat32bppPARGB, &data) == Gdiplus::Ok) {
+            request->bitmap->UnlockBits(&data);
+        }
+    }
+    QueryPerformanceCounter(&end);
+    request->decodeMs = (end.QuadPart - start.QuadPart) * 1000.0 / g_counterFrequency.QuadPart;
+}
+
+DWORD WINAPI DecodeThreadProc(LPVOID param) {
+    WaitForSingleObject(g_gdiplusReady, INFINITE);
+
+    for (;;) {
+        WaitForSingleObject(g_decodeWake, INFINITE);
+
+        EnterCriticalSection(&g_decodeLock);
+        DecodeRequest* request = g_pendingDecode;
+        g_pendingDecode = NULL;
+        bool stop = g_decodeStop;
+        LeaveCriticalSection(&g_decodeLock);
+
+        if (stop) {
+            delete request;
+            return 0;
+        }
+        if (!request) continue;
+
+        DecodeImage(request);
+        if (!request->bitmap) {
+            delete request;
+            continue;
+        }
+
+        // The window may already be gone; then nobody will take ownership
+        if (!PostMessage(request->hwnd, WM_APP_IMAGE_DECODED, 0, (LPARAM)request)) {
+            delete request->bitmap;
+            delete request;
+        }
+    }
+}
+
+void StopDecodeThread() {
+    EnterCriticalSection(&g_decodeLock);
+    g_decodeStop = true;
+    LeaveCriticalSection(&g_decodeLock);
+    SetEvent(g_decodeWake);
+    WaitForSingleObject(g_decodeThread, INFINITE);
+    CloseHandle(g_decodeThread);
+    CloseHandle(g_decodeWake);
+    DeleteCriticalSection(&g_decodeLock);
+
+    // Free results that were posted but never dispatched
+    MSG pending;
+    while (PeekMessage(&pending, NULL, WM_APP_IMAGE_DECODED, WM_APP_IMAGE_DECODED, PM_REMOVE)) {
+        DecodeRequest* request = (DecodeRequest*)pending.lParam;
+        delete request->bitmap;
+        delete request;
+    }
+}
+
 void LoadImage(HWND hwnd, LPCWSTR filename) {
-    g_pBitmap.reset(new Gdiplus::Bitmap(filename));
-    if (g_pBitmap->GetLastStatus() == Gdiplus::Ok) {
-        g_currentFile = filename;
-        LoadImageDirectory(filename);
-
-        if (g_fitToWindow) {
-            RECT clientRect;
-            GetClientRect(hwnd, &clientRect);
-            float windowRatio = (float)(clientRect.right - clientRect.left) / (clientRect.bottom - clientRect.top);
-            float imageRatio = (float)g_pBitmap->GetWidth() / g_pBitmap->GetHeight();
-            
-            if (imageRatio > windowRatio) {
-                g_zoom = (float)(clientRect.right - clientRect.left) / g_pBitmap->GetWidth();
-            } else {
-                g_zoom = (float)(clientRect.bottom - clientRect.top) / g_pBitmap->GetHeight();
-            }
-            g_targetZoom = g_zoom;
+    // Replace whatever is waiting in the slot; a request the worker has not
+    // picked up yet is dropped without being decoded
+    DecodeRequest* request = new DecodeRequest();
+    request->hwnd = hwnd;
+    request->generation = InterlockedIncrement(&g_decodeGeneration);
+    request->filename = filename;
+    request->bitmap = NULL;
+    request->decodeMs = 0.0;
+
+    EnterCriticalSection(&g_decodeLock);
+    delete g_pendingDecode;
+    g_pendingDecode = request;
+    LeaveCriticalSection(&g_decodeLock);
+    SetEvent(g_decodeWake);
+}
+
+void ShowImage(HWND hwnd, Gdiplus::Bitmap* bitmap, const std::wstring& filename) {
+    g_pBitmap.reset(bitmap);
+    g_currentFile = filename;
+
+    if (g_fitToWindow) {
+        RECT clientRect;
+        GetClientRect(hwnd, &clientRect);
+        float windowRatio = (float)(clientRect.right - clientRect.left) / (clientRect.bottom - clientRect.top);
+        float imageRatio = (float)g_pBitmap->GetWidth() / g_pBitmap->GetHeight();
+        
+        if (imageRatio > windowRatio) {
+            g_zoom = (float)(clientRect.right - clientRect.left) / g_pBitmap->GetWidth();
+        } else {
+            g_zoom = (float)(clientRect.bottom - clientRect.top) / g_pBitmap->GetHeight();
+        }
+        g_targetZoom = g_zoom;
+    }
+    UpdateBufferedBitmap(hwnd);
+    UpdateStatusBar(hwnd);
+    InvalidateRect(hwnd, NULL, TRUE);
+    UpdateWindow(hwnd);
+}
+
+bool HandOffToRunningInstance(const std::wstring& filename) {
+    HWND hwndExisting = FindWindowA(CLASS_NAME, NULL);
+    if (hwndExisting == NULL) return false;
+
+    if (!filename.empty()) {
+        COPYDATASTRUCT cds;
+        cds.dwData = COPYDATA_OPEN_FILE;
+        cds.cbData = (DWORD)((filename.size() + 1) * sizeof(wchar_t));
+        cds.lpData = (PVOID)filename.c_str();
+        DWORD_PTR result = 0;
+        if (!SendMessageTimeoutW(hwndExisting, WM_COPYDATA, 0, (LPARAM)&cds,
+                                 SMTO_ABORTIFHUNG, 5000, &result)) {
+            return false;
         }
-        UpdateBufferedBitmap(hwnd);
-        UpdateStatusBar(hwnd);
-        InvalidateRect(hwnd, NULL, TRUE);
     }
+
+    if (IsIconic(hwndExisting)) ShowWindow(hwndExisting, SW_RESTORE);
+    SetForegroundWindow(hwndExisting);
+    return true;
 }
 
 void SaveImage(HWND hwnd) {
@@ -410,6 +647,43 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
             return 0;
         }
 
+        case WM_APP_IMAGE_DECODED:
+        {
+            DecodeRequest* request = (DecodeRequest*)lParam;
+            bool current = request->generation == g_decodeGeneration;
+            bool shown = current && request->bitmap->GetLastStatus() == Gdiplus::Ok;
+            if (shown) {
+                ShowImage(hwnd, request->bitmap, request->filename);
+                request->bitmap = NULL;
+            }
+            delete request->bitmap;
+
+            if (current && g_startupImagePending) {
+                g_startupImagePending = false;
+                // Only a painted image counts; bench.ps1 treats a run without
+                // the "decoded and painted" line as a failure
+                MarkStartupPhase(shown ? "image decoded and painted" : "image decode failed");
+                g_startupPhases.push_back({ "  decode on worker (duration)", request->decodeMs });
+                ReportStartupPhases();
+                if (g_benchStartup) PostMessage(hwnd, WM_CLOSE, 0, 0);
+            }
+
+            // The image is already on screen; scanning the folder for
+            // navigation is not part of time-to-image
+            if (shown) LoadImageDirectory(request->filename);
+            delete request;
+            return 0;
+        }
+
+        case WM_COPYDATA:
+        {
+            PCOPYDATASTRUCT cds = (PCOPYDATASTRUCT)lParam;
+            if (cds->dwData != COPYDATA_OPEN_FILE || cds->cbData < sizeof(wchar_t)) break;
+            std::wstring filename((const wchar_t*)cds->lpData, cds->cbData / sizeof(wchar_t) - 1);
+            LoadImage(hwnd, filename.c_str());
+            return TRUE;
+        }
+
         case WM_DROPFILES:
         {
             HDROP hDrop = (HDROP)wParam;
@@ -630,18 +904,59 @@ int GetEncoderClsid(const WCHAR* format, CLSID* pClsid) {
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
     LPSTR lpCmdLine, int nCmdShow)
 {
-    // Initialize GDI+
-    Gdiplus::GdiplusStartupInput gdiplusStartupInput;
-    Gdiplus::GdiplusStartup(&g_gdiplusToken, &gdiplusStartupInput, NULL);
+    StartStartupClock();
+
+    // Parse the command line; lpCmdLine is ANSI, so use the wide version
+    // to keep non-ASCII paths from file associations intact
+    std::wstring startupFile;
+    int argc = 0;
+    LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    if (argv) {
+        for (int i = 1; i < argc; i++) {
+            if (wcscmp(argv[i], L"--bench-startup") == 0) {
+                g_benchStartup = true;
+            } else if (startupFile.empty()) {
+                WCHAR fullPath[MAX_PATH];
+                DWORD length = GetFullPathNameW(argv[i], MAX_PATH, fullPath, NULL);
+                startupFile = (length > 0 && length < MAX_PATH) ? fullPath : argv[i];
+            }
+        }
+        LocalFree(argv);
+    }
+
+    // Hand the file to an already running viewer instead of starting up.
+    // Benchmark runs always measure a full launch.
+    HANDLE hInstanceMutex = NULL;
+    if (!g_benchStartup) {
+        hInstanceMutex = CreateMutexW(NULL, FALSE, SINGLE_INSTANCE_MUTEX);
+        if (GetLastError() == ERROR_ALREADY_EXISTS && HandOffToRunningInstance(startupFile)) {
+            CloseHandle(hInstanceMutex);
+            return 0;
+        }
+    }
 
-    // Initialize Common Controls
+    // Initialize GDI+ in the background
+    g_gdiplusReady = CreateEvent(NULL, TRUE, FALSE, NULL);
+    HANDLE hGdiplusThread = CreateThread(NULL, 0, GdiplusStartupThreadProc, NULL, 0, NULL);
+    if (hGdiplusThread == NULL) {
+        GdiplusStartupThreadProc(NULL);
+    }
+
+    // Start the decode worker; it waits for GDI+ before the first decode
+    InitializeCriticalSection(&g_decodeLock);
+    g_decodeWake = CreateEvent(NULL, FALSE, FALSE, NULL);
+    g_decodeThread = CreateThread(NULL, 0, DecodeThreadProc, NULL, 0, NULL);
+    if (g_decodeThread == NULL) {
+        return 0;
+    }
+
+    // Initialize Common Controls (only the status bar is used)
     INITCOMMONCONTROLSEX icc;
     icc.dwSize = sizeof(icc);
-    icc.dwICC = ICC_WIN95_CLASSES;
+    icc.dwICC = ICC_BAR_CLASSES;
     InitCommonControlsEx(&icc);
+    MarkStartupPhase("common controls ready");
 
-    const char CLASS_NAME[]  = "Photo Viewer";
-    
     WNDCLASSEX wc = { 0 };
     wc.cbSize = sizeof(WNDCLASSEX);
     wc.lpfnWndProc   = WndProc;
@@ -672,6 +987,15 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
 
     ShowWindow(hwnd, nCmdShow);
     UpdateWindow(hwnd);
+    MarkStartupPhase("window shown");
+
+    if (!startupFile.empty()) {
+        g_startupImagePending = true;
+        LoadImage(hwnd, startupFile.c_str());
+    } else {
+        ReportStartupPhases();
+        if (g_benchStartup) PostMessage(hwnd, WM_CLOSE, 0, 0);
+    }
     
     MSG msg = { 0 };
     while (GetMessage(&msg, NULL, 0, 0))
@@ -680,7 +1004,16 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
         DispatchMessage(&msg);
     }
 
+    // No GDI+ object may outlive GdiplusShutdown
+    StopDecodeThread();
+    g_pBitmap.reset();
+    g_pBufferedBitmap.reset();
+
     // Shutdown GDI+
+    WaitForSingleObject(g_gdiplusReady, INFINITE);
+    if (hGdiplusThread) CloseHandle(hGdiplusThread);
+    CloseHandle(g_gdiplusReady);
     Gdiplus::GdiplusShutdown(g_gdiplusToken);
+    if (hInstanceMutex) CloseHandle(hInstanceMutex);
     return msg.wParam;
 }